@@ -0,0 +1,204 @@
+#define DT_DRV_COMPAT zmk_behavior_host_macro
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <drivers/behavior.h>
+
+#include <dt-bindings/kabarga/host_macro.h>
+
+#include <zmk/behavior.h>
+#include <zmk/ble.h>
+#include <zmk/endpoints.h>
+#include <zmk/keymap.h>
+
+#include "host_macro.h"
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1,
+             "Only one zmk,behavior-host-macro instance is supported");
+
+// One slot per BLE profile plus one for USB
+#define HOST_SLOT_USB ZMK_BLE_PROFILE_COUNT
+#define HOST_SLOT_COUNT (ZMK_BLE_PROFILE_COUNT + 1)
+#define HOST_VARIANT_NONE 0xFF
+
+struct behavior_host_macro_config {
+    size_t behavior_count;
+    struct zmk_behavior_binding *behaviors;
+};
+
+static uint8_t host_variants[HOST_SLOT_COUNT];
+// Variant fired by each held position, so its release goes to the same binding
+static uint8_t pressed_variants[ZMK_KEYMAP_LEN];
+
+static int get_host_slot() {
+    struct zmk_endpoint_instance endpoint = zmk_endpoints_selected();
+    if (endpoint.transport == ZMK_TRANSPORT_USB) {
+        return HOST_SLOT_USB;
+    }
+    return endpoint.ble.profile_index;
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+static uint32_t dirty_slots = 0;  // Slots waiting to be saved
+static uint32_t stored_slots = 0; // Slots with a record in flash
+
+static void host_macro_save_handler(struct k_work *work) {
+    char setting_name[15];
+
+    for (int i = 0; i < HOST_SLOT_COUNT; i++) {
+        if (dirty_slots & BIT(i)) {
+            sprintf(setting_name, "host_macro/%d", i);
+            settings_save_one(setting_name, &host_variants[i], sizeof(host_variants[i]));
+            stored_slots |= BIT(i);
+        }
+    }
+    dirty_slots = 0;
+}
+K_WORK_DELAYABLE_DEFINE(host_macro_save_work, host_macro_save_handler);
+
+static int host_macro_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+                                   void *cb_arg) {
+    if (name == NULL) {
+        return -EINVAL;
+    }
+
+    char *endptr;
+    unsigned long slot = strtoul(name, &endptr, 10);
+    if (endptr == name || *endptr != '\0' || slot >= HOST_SLOT_COUNT ||
+        len != sizeof(host_variants[0])) {
+        return -EINVAL;
+    }
+
+    int err = read_cb(cb_arg, &host_variants[slot], len);
+    if (err < 0) {
+        return err;
+    }
+    stored_slots |= BIT(slot);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(host_macro, "host_macro", NULL, host_macro_settings_set, NULL,
+                               NULL);
+#endif
+
+static void remember_variant(int slot, uint8_t variant) {
+    if (host_variants[slot] == variant) {
+        return;
+    }
+
+    host_variants[slot] = variant;
+#if IS_ENABLED(CONFIG_SETTINGS)
+    dirty_slots |= BIT(slot);
+    k_work_reschedule(&host_macro_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+#endif
+}
+
+int host_macro_clear(int slot) {
+    int erased_records = 0;
+
+    for (int i = 0; i < HOST_SLOT_COUNT; i++) {
+        if (slot != HOST_MACRO_ALL_SLOTS && slot != i) {
+            continue;
+        }
+
+        host_variants[i] = HOST_VARIANT_NONE;
+#if IS_ENABLED(CONFIG_SETTINGS)
+        dirty_slots &= ~BIT(i);
+        // Only slots with a record are erased, untouched hosts cost no flash write
+        if (stored_slots & BIT(i)) {
+            char setting_name[15];
+            sprintf(setting_name, "host_macro/%d", i);
+            settings_delete(setting_name);
+            stored_slots &= ~BIT(i);
+            erased_records++;
+        }
+#endif
+    }
+    return erased_records;
+}
+
+static int on_host_macro_binding_pressed(struct zmk_behavior_binding *binding,
+                                         struct zmk_behavior_binding_event event) {
+    const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
+    const struct behavior_host_macro_config *config = dev->config;
+    int slot = get_host_slot();
+
+    if (event.position >= ZMK_KEYMAP_LEN) {
+        LOG_ERR("Host macro bound to virtual position %d", event.position);
+        return -ENOTSUP;
+    }
+
+    if (binding->param1 != HOST_AUTO) {
+        if (binding->param1 > config->behavior_count) {
+            LOG_ERR("Host macro variant %d out of range", binding->param1);
+            return -ENOTSUP;
+        }
+        remember_variant(slot, binding->param1 - 1);
+    }
+
+    // Hosts never taught fall back to the first binding
+    uint8_t variant = host_variants[slot] < config->behavior_count ? host_variants[slot] : 0;
+    LOG_DBG("Host slot %d fires variant %d", slot, variant);
+
+    pressed_variants[event.position] = variant;
+    return zmk_behavior_invoke_binding(&config->behaviors[variant], event, true);
+}
+
+static int on_host_macro_binding_released(struct zmk_behavior_binding *binding,
+                                          struct zmk_behavior_binding_event event) {
+    const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
+    const struct behavior_host_macro_config *config = dev->config;
+
+    if (event.position >= ZMK_KEYMAP_LEN || pressed_variants[event.position] == HOST_VARIANT_NONE) {
+        return ZMK_BEHAVIOR_OPAQUE;
+    }
+
+    uint8_t variant = pressed_variants[event.position];
+    pressed_variants[event.position] = HOST_VARIANT_NONE;
+    return zmk_behavior_invoke_binding(&config->behaviors[variant], event, false);
+}
+
+static const struct behavior_driver_api behavior_host_macro_driver_api = {
+    .binding_pressed = on_host_macro_binding_pressed,
+    .binding_released = on_host_macro_binding_released,
+};
+
+static int behavior_host_macro_init(const struct device *dev) {
+    memset(host_variants, HOST_VARIANT_NONE, sizeof(host_variants));
+    memset(pressed_variants, HOST_VARIANT_NONE, sizeof(pressed_variants));
+    return 0;
+}
+
+#define _TRANSFORM_ENTRY(idx, node) ZMK_KEYMAP_EXTRACT_BINDING(idx, node)
+
+#define TRANSFORMED_BINDINGS(node)                                                                 \
+    {LISTIFY(DT_INST_PROP_LEN(node, bindings), _TRANSFORM_ENTRY, (, ), DT_DRV_INST(node))}
+
+#define HM_INST(n)                                                                                 \
+    static struct zmk_behavior_binding behavior_host_macro_config_##n##_bindings[] =               \
+        TRANSFORMED_BINDINGS(n);                                                                   \
+    static const struct behavior_host_macro_config behavior_host_macro_config_##n = {              \
+        .behavior_count = DT_INST_PROP_LEN(n, bindings),                                           \
+        .behaviors = behavior_host_macro_config_##n##_bindings,                                    \
+    };                                                                                             \
+    BEHAVIOR_DT_INST_DEFINE(n, behavior_host_macro_init, NULL, NULL,                               \
+                            &behavior_host_macro_config_##n, POST_KERNEL,                          \
+                            CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &behavior_host_macro_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(HM_INST)
+
+#else
+
+int host_macro_clear(int slot) { return 0; }
+
+#endif
@@ -0,0 +1,60 @@
+#define DT_DRV_COMPAT zmk_behavior_settings_clear
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <drivers/behavior.h>
+
+#include <dt-bindings/kabarga/settings_clear.h>
+
+#include <zmk/behavior.h>
+#include <zmk/ble.h>
+
+#include "host_macro.h"
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+static int on_settings_clear_binding_pressed(struct zmk_behavior_binding *binding,
+                                             struct zmk_behavior_binding_event event) {
+    int64_t start = k_uptime_ticks();
+    int erased_records;
+
+    switch (binding->param1) {
+    case SETTINGS_CLEAR_PROFILE:
+        // The bond wipe (bt_unpair and the profile save) is done by ZMK and is not counted here
+        erased_records = host_macro_clear(zmk_ble_active_profile_index());
+        zmk_ble_clear_bonds();
+        break;
+    case SETTINGS_CLEAR_HOST_MACRO:
+        erased_records = host_macro_clear(HOST_MACRO_ALL_SLOTS);
+        break;
+    default:
+        LOG_ERR("Unknown settings clear command %d", binding->param1);
+        return -ENOTSUP;
+    }
+
+    LOG_INF("Settings clear %d done in %u us, %d host macro record(s) erased", binding->param1,
+            k_ticks_to_us_ceil32(k_uptime_ticks() - start), erased_records);
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static int on_settings_clear_binding_released(struct zmk_behavior_binding *binding,
+                                              struct zmk_behavior_binding_event event) {
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static const struct behavior_driver_api behavior_settings_clear_driver_api = {
+    .binding_pressed = on_settings_clear_binding_pressed,
+    .binding_released = on_settings_clear_binding_released,
+};
+
+#define SC_INST(n)                                                                                 \
+    BEHAVIOR_DT_INST_DEFINE(n, NULL, NULL, NULL, NULL, POST_KERNEL,                                \
+                            CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,                                   \
+                            &behavior_settings_clear_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SC_INST)
+
+#endif
@@ -0,0 +1,118 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/sys/iterable_sections.h>
+
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Tracks the usage of every net_buf pool (BT ACL TX/RX, HCI events, ...) by sampling their free
+// counts while the board is active, and reports a recommended size for each pool when it goes
+// idle. Bursts shorter than a sample are missed, so the sampled peak is only a lower bound of
+// the real high-water mark and the recommendation keeps generous headroom above it.
+
+#define BUF_STATS_SAMPLE_MS CONFIG_KABARGA_BUF_STATS_SAMPLE_MS
+#define BUF_STATS_MAX_POOLS 16
+
+static uint16_t min_avail[BUF_STATS_MAX_POOLS];
+static uint32_t starved_samples[BUF_STATS_MAX_POOLS]; // Samples that found the pool empty
+static uint32_t sample_count = 0;
+static bool is_sampling = false;
+
+void buf_stats_sample_handler(struct k_work *work);
+K_WORK_DELAYABLE_DEFINE(buf_stats_sample_work, buf_stats_sample_handler);
+
+void buf_stats_sample_handler(struct k_work *work) {
+    int i = 0;
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool) {
+        if (i >= BUF_STATS_MAX_POOLS) {
+            break;
+        }
+
+        uint16_t avail = atomic_get(&pool->avail_count);
+        min_avail[i] = MIN(min_avail[i], avail);
+        if (avail == 0) {
+            starved_samples[i]++;
+        }
+        i++;
+    }
+    sample_count++;
+
+    if (is_sampling) {
+        k_work_schedule(&buf_stats_sample_work, K_MSEC(BUF_STATS_SAMPLE_MS));
+    }
+}
+
+static void buf_stats_start() {
+    is_sampling = true;
+    k_work_schedule(&buf_stats_sample_work, K_MSEC(BUF_STATS_SAMPLE_MS));
+}
+
+static void buf_stats_stop() {
+    is_sampling = false;
+    k_work_cancel_delayable(&buf_stats_sample_work);
+}
+
+static void buf_stats_report() {
+    size_t total_savings = 0;
+    int i = 0;
+
+    LOG_INF("net_buf pool usage over %u samples:", sample_count);
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool) {
+        if (i >= BUF_STATS_MAX_POOLS) {
+            break;
+        }
+
+        uint16_t peak = pool->buf_count - min_avail[i];
+        // Half the sampled peak (at least 2) as headroom for missed bursts, and no reduction
+        // at all for a pool that was ever found empty
+        uint16_t recommended = starved_samples[i] > 0
+                                   ? pool->buf_count
+                                   : MIN(pool->buf_count, peak + MAX(2, peak / 2));
+        size_t buf_ram =
+            pool->pool_size / pool->buf_count + sizeof(struct net_buf) + pool->user_data_size;
+        size_t savings = (pool->buf_count - recommended) * buf_ram;
+
+        LOG_INF("%s: sampled peak >= %u/%u, starved %u, recommended %u, saves %zu bytes",
+                pool->name, peak, pool->buf_count, starved_samples[i], recommended, savings);
+        total_savings += savings;
+        i++;
+    }
+    LOG_INF("Recommended sizes save %zu bytes of RAM", total_savings);
+}
+
+int buf_stats_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *ev = as_zmk_activity_state_changed(eh);
+    if (ev == NULL) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    if (ev->state == ZMK_ACTIVITY_ACTIVE) {
+        buf_stats_start();
+    } else if (is_sampling) {
+        buf_stats_stop();
+        buf_stats_report();
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(buf_stats, buf_stats_listener)
+ZMK_SUBSCRIPTION(buf_stats, zmk_activity_state_changed);
+
+static int buf_stats_init() {
+    int i = 0;
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool) {
+        if (i >= BUF_STATS_MAX_POOLS) {
+            LOG_WRN("More than %d net_buf pools, the rest are not tracked", BUF_STATS_MAX_POOLS);
+            break;
+        }
+        min_avail[i++] = pool->buf_count;
+    }
+
+    buf_stats_start();
+    return 0;
+}
+
+SYS_INIT(buf_stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
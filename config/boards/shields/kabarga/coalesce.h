@@ -0,0 +1,31 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+// Slack for non-critical periodic work (connection checks)
+#define COALESCE_SLACK_MS CONFIG_KABARGA_COALESCE_SLACK_MS
+
+// Reschedule non-critical work to expire within [delay_ms, delay_ms + slack_ms]. The deadline
+// is rounded up to a multiple of slack_ms in uptime, so jobs sharing a slack expire on the
+// same tick and wake the CPU once. Rescheduling to the deadline already armed is a no-op.
+static inline int coalesce_work_reschedule_for_queue(struct k_work_q *queue,
+                                                     struct k_work_delayable *dwork,
+                                                     uint32_t delay_ms, uint32_t slack_ms) {
+    int64_t deadline_ms = k_uptime_get() + delay_ms;
+    if (slack_ms > 0) {
+        // Round in 64 bits, ROUND_UP() works on unsigned long and wraps after 49.7 days
+        deadline_ms = ((deadline_ms + slack_ms - 1) / slack_ms) * slack_ms;
+    }
+
+    if (k_work_delayable_is_pending(dwork) &&
+        k_work_delayable_expires_get(dwork) == k_ms_to_ticks_ceil64(deadline_ms)) {
+        return 0;
+    }
+    return k_work_reschedule_for_queue(queue, dwork, K_TIMEOUT_ABS_MS(deadline_ms));
+}
+
+static inline int coalesce_work_reschedule(struct k_work_delayable *dwork, uint32_t delay_ms,
+                                           uint32_t slack_ms) {
+    return coalesce_work_reschedule_for_queue(&k_sys_work_q, dwork, delay_ms, slack_ms);
+}
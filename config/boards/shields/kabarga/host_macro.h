@@ -0,0 +1,8 @@
+#pragma once
+
+// Clear every host slot instead of a single one
+#define HOST_MACRO_ALL_SLOTS -1
+
+// Forgets the macro chosen for a host slot (BLE profile index, or the USB slot after the last
+// profile) and erases its stored record. Returns the number of host macro records erased.
+int host_macro_clear(int slot);
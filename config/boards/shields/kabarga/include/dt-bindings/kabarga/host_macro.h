@@ -0,0 +1,8 @@
+#pragma once
+
+// Parameters of zmk,behavior-host-macro: HOST_AUTO fires the choice cached for the active
+// host, any other value selects binding N (1-based), remembers it and fires it
+#define HOST_AUTO 0
+#define HOST_UNLOCK 1
+#define HOST_MACOS 2
+#define HOST_RASPBERRYPI 3
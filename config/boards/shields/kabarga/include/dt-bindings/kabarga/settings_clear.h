@@ -0,0 +1,5 @@
+#pragma once
+
+// Parameters of zmk,behavior-settings-clear
+#define SETTINGS_CLEAR_PROFILE 0
+#define SETTINGS_CLEAR_HOST_MACRO 1
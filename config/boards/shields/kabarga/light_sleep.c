@@ -0,0 +1,122 @@
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <zmk/activity.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
+
+#include "status_led.h"
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Two sleep tiers: ZMK_ACTIVITY_IDLE (CONFIG_ZMK_IDLE_TIMEOUT) is a light sleep that keeps
+// the BLE link with maximal peripheral latency, so a keypress still goes out on the next
+// connection event. System OFF only comes with ZMK_ACTIVITY_SLEEP (CONFIG_ZMK_IDLE_SLEEP_TIMEOUT).
+//
+// Only light sleep residency and the time the host takes to restore the active link
+// parameters are logged. The keypress to report latency out of light sleep depends on where
+// the press lands between connection events and needs a sniffer or a host timestamp. System OFF
+// residency and wake latency are not measured either: the RAM holding the counters is lost and
+// the wake is a cold boot.
+
+// Connection parameters while active, same as the ones the keyboard advertises
+#define ACTIVE_CONN_PARAM                                                                          \
+    BT_LE_CONN_PARAM(CONFIG_BT_PERIPHERAL_PREF_MIN_INT, CONFIG_BT_PERIPHERAL_PREF_MAX_INT,         \
+                     CONFIG_BT_PERIPHERAL_PREF_LATENCY, CONFIG_BT_PERIPHERAL_PREF_TIMEOUT)
+
+// Supervision timeout must stay above (1 + latency) * interval * 2
+#define LIGHT_SLEEP_TIMEOUT                                                                        \
+    MAX(CONFIG_BT_PERIPHERAL_PREF_TIMEOUT,                                                         \
+        (1 + CONFIG_KABARGA_LIGHT_SLEEP_LATENCY) * CONFIG_BT_PERIPHERAL_PREF_MAX_INT / 4 + 100)
+
+#define LIGHT_SLEEP_CONN_PARAM                                                                     \
+    BT_LE_CONN_PARAM(CONFIG_BT_PERIPHERAL_PREF_MIN_INT, CONFIG_BT_PERIPHERAL_PREF_MAX_INT,         \
+                     CONFIG_KABARGA_LIGHT_SLEEP_LATENCY, LIGHT_SLEEP_TIMEOUT)
+
+BUILD_ASSERT(LIGHT_SLEEP_TIMEOUT <= 3200, "Light sleep latency too high for the connection interval");
+
+static bool is_light_sleep = false;
+static bool is_waking = false;
+static int64_t light_sleep_enter_time = 0;
+static int64_t light_sleep_wake_time = 0;
+static int64_t light_sleep_total_ms = 0; // Light sleep residency since boot
+
+static void update_conn_param(struct bt_conn *conn, void *data) {
+    struct bt_conn_info info;
+    if (bt_conn_get_info(conn, &info) || info.role != BT_CONN_ROLE_PERIPHERAL ||
+        info.state != BT_CONN_STATE_CONNECTED) {
+        return;
+    }
+
+    int err = bt_conn_le_param_update(conn, (const struct bt_le_conn_param *)data);
+    if (err) {
+        LOG_WRN("Failed to update connection parameters (err %d)", err);
+    }
+}
+
+void light_sleep_leds_handler(struct k_work *work) { turn_off_all_leds(); }
+K_WORK_DEFINE(light_sleep_leds_work, light_sleep_leds_handler);
+
+static void enter_light_sleep() {
+    is_light_sleep = true;
+    is_waking = false;
+    light_sleep_enter_time = k_uptime_get();
+
+    // Queued behind any running animation, so the LEDs and PWM end up idle
+    k_work_submit_to_queue(&animation_work_q, &light_sleep_leds_work);
+    bt_conn_foreach(BT_CONN_TYPE_LE, update_conn_param, LIGHT_SLEEP_CONN_PARAM);
+}
+
+static void exit_light_sleep() {
+    int64_t residency = k_uptime_get() - light_sleep_enter_time;
+
+    is_light_sleep = false;
+    light_sleep_total_ms += residency;
+    LOG_INF("Light sleep residency %lld ms (total %lld ms)", residency, light_sleep_total_ms);
+}
+
+int light_sleep_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *ev = as_zmk_activity_state_changed(eh);
+    if (ev == NULL) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    switch (ev->state) {
+    case ZMK_ACTIVITY_IDLE:
+        enter_light_sleep();
+        break;
+    case ZMK_ACTIVITY_ACTIVE:
+        if (is_light_sleep) {
+            exit_light_sleep();
+            is_waking = true;
+            light_sleep_wake_time = k_uptime_get();
+            bt_conn_foreach(BT_CONN_TYPE_LE, update_conn_param, ACTIVE_CONN_PARAM);
+        }
+        break;
+    case ZMK_ACTIVITY_SLEEP:
+        if (is_light_sleep) {
+            exit_light_sleep();
+        }
+        LOG_INF("Entering System OFF");
+        break;
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(light_sleep, light_sleep_listener)
+ZMK_SUBSCRIPTION(light_sleep, zmk_activity_state_changed);
+
+static void light_sleep_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                                      uint16_t timeout) {
+    if (!is_waking || latency != CONFIG_BT_PERIPHERAL_PREF_LATENCY) {
+        return;
+    }
+
+    is_waking = false;
+    LOG_INF("Link parameters restored in %lld ms", k_uptime_get() - light_sleep_wake_time);
+}
+
+BT_CONN_CB_DEFINE(light_sleep_conn_callbacks) = {
+    .le_param_updated = light_sleep_param_updated,
+};
@@ -0,0 +1,123 @@
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+
+#include <zmk/activity.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
+
+#include "status_led.h"
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Devices kabarga owns, consumers before the peripherals they sit on. Entries whose driver
+// may not be built follow its Kconfig. Underglow is not audited here, ZMK suspends the strip
+// with the remaining devices.
+//
+// ZMK suspends the remaining devices and enters System OFF right after the ZMK_ACTIVITY_SLEEP
+// event, from the same system workqueue item. If it aborts instead, that item returns and
+// sleep_audit_resume_work runs, resuming what was suspended here: ZMK only resumes the devices
+// it suspended itself.
+
+struct managed_device {
+    const struct device *dev;
+    bool suspend; // Wakeup sources are only audited, ZMK arms them for System OFF
+};
+
+#define MANAGED_NODE(node_id, do_suspend)                                                          \
+    {.dev = DEVICE_DT_GET_OR_NULL(node_id), .suspend = do_suspend}
+
+#define MANAGED_COMPAT(compat, do_suspend)                                                         \
+    {.dev = COND_CODE_1(DT_HAS_COMPAT_STATUS_OKAY(compat),                                         \
+                        (DEVICE_DT_GET(DT_INST(0, compat))), (NULL)),                              \
+     .suspend = do_suspend}
+
+static const struct managed_device managed_devices[] = {
+    MANAGED_NODE(DT_CHOSEN(zmk_backlight), true),
+    MANAGED_NODE(DT_NODELABEL(pwm0), true),
+#if IS_ENABLED(CONFIG_ZMK_EXT_POWER)
+    MANAGED_COMPAT(zmk_ext_power_generic, true),
+#endif
+#if IS_ENABLED(CONFIG_ADC)
+    MANAGED_NODE(DT_NODELABEL(adc), true),
+#endif
+    MANAGED_NODE(DT_CHOSEN(zmk_kscan), false),
+};
+
+static bool suspended_here[ARRAY_SIZE(managed_devices)];
+
+void sleep_audit_resume_handler(struct k_work *work) {
+    int resumed_count = 0;
+
+    // Providers before their consumers
+    for (int i = ARRAY_SIZE(managed_devices) - 1; i >= 0; i--) {
+        if (!suspended_here[i]) {
+            continue;
+        }
+
+        int err = pm_device_action_run(managed_devices[i].dev, PM_DEVICE_ACTION_RESUME);
+        if (err && err != -EALREADY) {
+            LOG_WRN("Failed to resume %s (err %d)", managed_devices[i].dev->name, err);
+        }
+        suspended_here[i] = false;
+        resumed_count++;
+    }
+
+    LOG_WRN("Sleep entry aborted, resumed %d device(s)", resumed_count);
+}
+K_WORK_DEFINE(sleep_audit_resume_work, sleep_audit_resume_handler);
+
+static void suspend_managed_devices() {
+    int64_t start = k_uptime_ticks();
+    int active_count = 0;
+
+    turn_off_all_leds();
+
+    for (int i = 0; i < ARRAY_SIZE(managed_devices); i++) {
+        const struct managed_device *md = &managed_devices[i];
+        enum pm_device_state state;
+
+        if (md->dev == NULL) {
+            continue;
+        }
+
+        if (md->suspend) {
+            int err = pm_device_action_run(md->dev, PM_DEVICE_ACTION_SUSPEND);
+            if (err == 0) {
+                suspended_here[i] = true;
+            } else if (err != -EALREADY && err != -ENOSYS) {
+                LOG_WRN("Failed to suspend %s (err %d)", md->dev->name, err);
+            }
+        }
+
+        if (pm_device_state_get(md->dev, &state)) {
+            LOG_INF("%s: no PM support", md->dev->name);
+            continue;
+        }
+
+        LOG_INF("%s: %s", md->dev->name, pm_device_state_str(state));
+        if (md->suspend && state == PM_DEVICE_STATE_ACTIVE) {
+            LOG_WRN("%s is still active", md->dev->name);
+            active_count++;
+        }
+    }
+
+    LOG_INF("Sleep entry took %u us, %d device(s) left active",
+            k_ticks_to_us_ceil32(k_uptime_ticks() - start), active_count);
+
+    // Only runs if ZMK returns to the workqueue instead of entering System OFF
+    k_work_submit(&sleep_audit_resume_work);
+}
+
+int sleep_audit_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *ev = as_zmk_activity_state_changed(eh);
+    if (ev && ev->state == ZMK_ACTIVITY_SLEEP) {
+        suspend_managed_devices();
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(sleep_audit, sleep_audit_listener)
+ZMK_SUBSCRIPTION(sleep_audit, zmk_activity_state_changed);
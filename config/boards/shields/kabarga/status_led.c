@@ -20,20 +20,30 @@
 #include <zmk/events/activity_state_changed.h>
 #include <zmk/events/battery_state_changed.h>
 #include <zmk/events/ble_active_profile_changed.h>
+#include <zmk/events/split_peripheral_status_changed.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/hid_indicators.h>
 #include <zmk/keymap.h>
+#include <zmk/split/bluetooth/peripheral.h>
 #include <zmk/usb.h>
 #include <zmk/workqueue.h>
 
+#include "coalesce.h"
+#include "status_led.h"
+
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Keyboard built as the peripheral of kabarga_dongle: no host profiles, only the dongle link
+#define IS_SPLIT_PERIPHERAL                                                                        \
+    (IS_ENABLED(CONFIG_ZMK_SPLIT) && !IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
+
 // Define fade durations for different modes
 #define FADE_DURATION_PROFILE_MS 400
 #define FADE_DURATION_BATTERY_MS 800
 #define FADE_DURATION_USB_MS 400
 #define FADE_DURATION_DISCONNECT_MS 300
 #define BLINK_HOLD_DURATION_MS 100
+#define CONNECTION_CHECK_INTERVAL_MS 4000
 
 #define LED_STATUS_ON 100
 #define LED_STATUS_OFF 0
@@ -74,12 +84,11 @@ struct Led individual_leds[LED_COUNT] = {
 // Global state variables
 bool is_connection_checking = false;
 int usb_conn_state = ZMK_USB_CONN_NONE;
-static int profile_count_blink = 1;
 static uint8_t led_brightness[LED_COUNT] = {0};// Store the brightness of each LED
 
-// Define stack size and priority for animation workqueue
-#define ANIMATION_WORK_Q_STACK_SIZE 1024
-#define ANIMATION_WORK_Q_PRIORITY 5
+// Stack size and priority for animation workqueue, see Kconfig.defconfig for the priority map
+#define ANIMATION_WORK_Q_STACK_SIZE CONFIG_KABARGA_ANIMATION_WORK_Q_STACK_SIZE
+#define ANIMATION_WORK_Q_PRIORITY CONFIG_KABARGA_ANIMATION_WORK_Q_PRIORITY
 
 // Define stack area for animation workqueue
 K_THREAD_STACK_DEFINE(animation_work_q_stack, ANIMATION_WORK_Q_STACK_SIZE);
@@ -87,8 +96,14 @@ K_THREAD_STACK_DEFINE(animation_work_q_stack, ANIMATION_WORK_Q_STACK_SIZE);
 // Define workqueue object
 struct k_work_q animation_work_q;
 
-// Helper function to set brightness of individual LED
+// Helper function to set brightness of individual LED.
+// At 0 and 100 % the nRF PWM driver drives the pin as a plain GPIO and stops pwm0 (releasing
+// its HFCLK request) once no channel is left at an intermediate level, so only fades keep the
+// peripheral running. Unchanged levels are skipped to keep plateaus free of PWM updates.
 static inline void set_individual_led_brightness(LedType led, uint8_t brightness) {
+    if (led_brightness[led] == brightness) {
+        return;
+    }
     led_set_brightness(individual_leds[led].dev, individual_leds[led].id, brightness);
     led_brightness[led] = brightness;  // Store the brightness value
 }
@@ -97,6 +112,7 @@ void turn_off_all_leds() {
     for (int i = 0; i < LED_COUNT; i++) {
         const struct Led *led = &individual_leds[i];
         led_off(led->dev, led->id);
+        led_brightness[i] = LED_STATUS_OFF;
     }
     return;
 }
@@ -155,18 +171,33 @@ void smooth_blink_leds(uint8_t led_mask, int count, uint32_t duration_ms) {
     }
 }
 
+static bool is_link_connected() {
+#if IS_SPLIT_PERIPHERAL
+    return zmk_split_bt_peripheral_is_connected();
+#else
+    return zmk_ble_active_profile_is_connected() || usb_conn_state != ZMK_USB_CONN_NONE;
+#endif
+}
+
 struct k_work_delayable check_ble_conn_work;
 
+// The check blinks with k_msleep, keep it on the animation queue so it never stalls
+// the system workqueue that processes key events and sends HID reports
+static void schedule_connection_check() {
+    coalesce_work_reschedule_for_queue(&animation_work_q, &check_ble_conn_work,
+                                       CONNECTION_CHECK_INTERVAL_MS, COALESCE_SLACK_MS);
+}
+
 void check_bluetooth_connection_handler(struct k_work *work) {
     if (!is_connection_checking) {
         return;
     } else {
-        if (zmk_ble_active_profile_is_connected() || usb_conn_state != ZMK_USB_CONN_NONE) {
+        if (is_link_connected()) {
             is_connection_checking = false;
             return;
         } else {
             smooth_blink_leds(0b0001, 1, FADE_DURATION_DISCONNECT_MS);
-            k_work_reschedule(&check_ble_conn_work, K_SECONDS(4));
+            schedule_connection_check();
             return;
         }
     }
@@ -214,23 +245,33 @@ static int initialize_leds(const struct device *dev) {
     turn_off_all_leds();
     k_work_queue_init(&animation_work_q);
 
+    // Named so the queue thread shows up in traces and thread analyzers
+    const struct k_work_queue_config animation_work_q_config = {.name = "animation_work_q"};
     k_work_queue_start(&animation_work_q, animation_work_q_stack,
                        K_THREAD_STACK_SIZEOF(animation_work_q_stack), ANIMATION_WORK_Q_PRIORITY,
-                       NULL);
+                       &animation_work_q_config);
 
     k_work_schedule_for_queue(&animation_work_q, &battery_animation_work, K_SECONDS(1));
+#if IS_SPLIT_PERIPHERAL
+    // Not linked to the dongle yet at boot, no status event comes until the first connection
+    is_connection_checking = true;
+    schedule_connection_check();
+#endif
     return 0;
 }
 
 SYS_INIT(initialize_leds, APPLICATION, 32);
 
+#if !IS_SPLIT_PERIPHERAL
+static int profile_count_blink = 1;
+
 struct k_work_delayable ble_profile_work;
 
 void ble_profile_handler(struct k_work *work) {
     smooth_blink_leds(0b1000 >> (profile_count_blink), 1, FADE_DURATION_PROFILE_MS);
     if (!is_connection_checking) {
         is_connection_checking = true;
-        k_work_reschedule(&check_ble_conn_work, K_SECONDS(4));
+        schedule_connection_check();
     }
 }
 
@@ -246,6 +287,21 @@ K_WORK_DELAYABLE_DEFINE(ble_profile_work, ble_profile_handler);
 
 ZMK_LISTENER(ble_profile_status, ble_profile_listener)
 ZMK_SUBSCRIPTION(ble_profile_status, zmk_ble_active_profile_changed);
+#else
+// As the dongle's peripheral there are no profiles, blink while the dongle link is down
+int split_peripheral_status_listener(const zmk_event_t *eh) {
+    const struct zmk_split_peripheral_status_changed *status_ev =
+        as_zmk_split_peripheral_status_changed(eh);
+    if (status_ev && !status_ev->connected && !is_connection_checking) {
+        is_connection_checking = true;
+        schedule_connection_check();
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_peripheral_status, split_peripheral_status_listener)
+ZMK_SUBSCRIPTION(split_peripheral_status, zmk_split_peripheral_status_changed);
+#endif
 
 struct k_work_delayable usb_conn_work;
 
@@ -254,7 +310,7 @@ void usb_connection_handler(struct k_work *work) {
         k_work_schedule_for_queue(&animation_work_q, &usb_animation_work, K_NO_WAIT);
     } else {
         is_connection_checking = true;
-        k_work_reschedule(&check_ble_conn_work, K_SECONDS(4));
+        schedule_connection_check();
     }
 }
 
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+
+// Workqueue running the status LED animations, see status_led.c
+extern struct k_work_q animation_work_q;
+
+void turn_off_all_leds();